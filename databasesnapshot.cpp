@@ -0,0 +1,282 @@
+#include "databasesnapshot.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QThread>
+#include <QFutureWatcher>
+#include <QPair>
+#include <QtConcurrent/QtConcurrentRun>
+
+// Backup files start with this tag, followed by qCompress()ed chunks of the
+// database image serialized as QByteArrays and an empty chunk as terminator.
+static const quint32 BackupMagic = 0x4c4e424b; // "LNBK"
+static const quint32 BackupVersion = 1;
+static const QDataStream::Version BackupStreamVersion = QDataStream::Qt_6_0;
+static const qint64 BackupChunkSize = 1024 * 1024;
+
+DatabaseSnapshot::DatabaseSnapshot(const QString &sourceDatabase) :
+    m_connectionName(QString("snapshot_%1").arg(quintptr(this)))
+{
+    if (!m_dir.isValid()) {
+        m_lastError = m_dir.errorString();
+        return;
+    }
+
+    const QString path = m_dir.filePath("snapshot.db");
+    if (!copy(sourceDatabase, path, &m_lastError)) return;
+
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_db.setDatabaseName(path);
+    m_db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!m_db.open()) {
+        m_lastError = m_db.lastError().text();
+    }
+}
+
+DatabaseSnapshot::~DatabaseSnapshot()
+{
+    if (!m_db.isValid()) return;
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+bool DatabaseSnapshot::copy(const QString &source, const QString &destination, QString *error)
+{
+    // VACUUM INTO refuses to write over an existing non-empty file.
+    QFile::remove(destination);
+
+    const QString connName = QString("snapshot_copy_%1").arg(quintptr(QThread::currentThreadId()));
+    QString message;
+    {
+        QSqlDatabase src = QSqlDatabase::addDatabase("QSQLITE", connName);
+        src.setDatabaseName(source);
+        src.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!src.open()) {
+            message = QString("Cannot open %1: %2").arg(source, src.lastError().text());
+        } else {
+            // VACUUM INTO reads the source in one read transaction, so the
+            // copy is consistent; under WAL it does not block writers.
+            QSqlQuery q(src);
+            q.prepare("VACUUM INTO ?");
+            q.addBindValue(destination);
+            if (!q.exec()) message = q.lastError().text();
+        }
+        src.close();
+    }
+    QSqlDatabase::removeDatabase(connName);
+
+    // The copy may carry the source's WAL flag; switch it back to a plain
+    // rollback journal so it is a single self-contained file.
+    if (message.isEmpty()) {
+        {
+            QSqlDatabase dst = QSqlDatabase::addDatabase("QSQLITE", connName);
+            dst.setDatabaseName(destination);
+            if (!dst.open()) {
+                message = dst.lastError().text();
+            } else {
+                QSqlQuery q(dst);
+                if (!q.exec("PRAGMA journal_mode=DELETE")) message = q.lastError().text();
+            }
+            dst.close();
+        }
+        QSqlDatabase::removeDatabase(connName);
+    }
+
+    if (!message.isEmpty()) {
+        qDebug() << "Database snapshot failed:" << message;
+        QFile::remove(destination);
+        if (error) *error = message;
+        return false;
+    }
+    return true;
+}
+
+// --- BackupScheduler ---
+
+BackupScheduler::BackupScheduler(const QString &databaseName, const QString &backupDir, QObject *parent) :
+    QObject(parent),
+    m_databaseName(databaseName),
+    m_backupDir(backupDir),
+    m_keepCount(7),
+    m_running(false)
+{
+    connect(&m_timer, &QTimer::timeout, this, &BackupScheduler::backupNow);
+}
+
+void BackupScheduler::start(int intervalMinutes)
+{
+    const int minutes = qMax(1, intervalMinutes);
+
+    // The app is usually closed well before a full interval has passed, so
+    // catch up on startup instead of waiting for the first timeout.
+    const QString baseName = QFileInfo(m_databaseName).completeBaseName();
+    const QFileInfoList backups = QDir(m_backupDir).entryInfoList({baseName + "_*.db.qz"}, QDir::Files, QDir::Time);
+    if (backups.isEmpty()
+        || backups.first().lastModified().secsTo(QDateTime::currentDateTime()) >= qint64(minutes) * 60) {
+        backupNow();
+    }
+
+    m_timer.start(minutes * 60 * 1000);
+}
+
+void BackupScheduler::backupNow()
+{
+    if (m_running) return;
+    m_running = true;
+
+    auto *watcher = new QFutureWatcher<QPair<bool, QString>>(this);
+    connect(watcher, &QFutureWatcher<QPair<bool, QString>>::finished, this, [this, watcher]() {
+        const QPair<bool, QString> result = watcher->result();
+        m_running = false;
+        emit backupFinished(result.first, result.second);
+        watcher->deleteLater();
+    });
+
+    const QString databaseName = m_databaseName;
+    const QString backupDir = m_backupDir;
+    const int keepCount = m_keepCount;
+    watcher->setFuture(QtConcurrent::run([databaseName, backupDir, keepCount]() {
+        bool ok = false;
+        QString res = writeBackup(databaseName, backupDir, keepCount, &ok);
+        return qMakePair(ok, res);
+    }));
+}
+
+QString BackupScheduler::writeBackup(const QString &databaseName, const QString &backupDir, int keepCount, bool *ok)
+{
+    *ok = false;
+
+    QDir dir(backupDir);
+    if (!dir.mkpath(".")) {
+        return QString("Cannot create backup directory %1").arg(backupDir);
+    }
+
+    const QString baseName = QFileInfo(databaseName).completeBaseName();
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    const QString rawPath = dir.filePath(QString("%1_%2.db.tmp").arg(baseName, stamp));
+    const QString finalPath = dir.filePath(QString("%1_%2.db.qz").arg(baseName, stamp));
+
+    // Leftovers from a backup that was interrupted by a crash: the raw copy
+    // and QSaveFile's temporary next to the compressed file
+    const QStringList stale = dir.entryList({baseName + "_*.db.tmp", baseName + "_*.db.qz.*"}, QDir::Files);
+    for (const QString &name : stale) {
+        dir.remove(name);
+    }
+
+    QString error;
+    if (!DatabaseSnapshot::copy(databaseName, rawPath, &error)) {
+        return error;
+    }
+
+    // QSaveFile only renames to the final *.db.qz name on commit(), so an
+    // interrupted backup never looks like a complete one.
+    QFile raw(rawPath);
+    QSaveFile out(finalPath);
+    if (!raw.open(QIODevice::ReadOnly)) {
+        error = raw.errorString();
+    } else if (!out.open(QIODevice::WriteOnly)) {
+        error = QString("Failed to write %1: %2").arg(finalPath, out.errorString());
+    } else {
+        QDataStream stream(&out);
+        stream.setVersion(BackupStreamVersion);
+        stream << BackupMagic << BackupVersion;
+        while (!raw.atEnd()) {
+            const QByteArray chunk = raw.read(BackupChunkSize);
+            if (chunk.isEmpty()) {
+                error = raw.errorString();
+                break;
+            }
+            stream << qCompress(chunk);
+        }
+        stream << QByteArray();
+        if (error.isEmpty() && (stream.status() != QDataStream::Ok || !out.commit())) {
+            error = QString("Failed to write %1: %2").arg(finalPath, out.errorString());
+        }
+    }
+    raw.close();
+    QFile::remove(rawPath);
+
+    if (!error.isEmpty()) {
+        out.cancelWriting();
+        return error;
+    }
+
+    // Drop the oldest backups; names sort chronologically.
+    const QStringList backups = dir.entryList({baseName + "_*.db.qz"}, QDir::Files, QDir::Name | QDir::Reversed);
+    for (int i = keepCount; i < backups.size(); ++i) {
+        dir.remove(backups.at(i));
+    }
+
+    *ok = true;
+    return finalPath;
+}
+
+bool BackupScheduler::restore(const QString &backupPath, const QString &destination, QString *error)
+{
+    QString message;
+    QFile in(backupPath);
+
+    // QSaveFile decodes into a temporary file next to destination and only
+    // replaces it on commit(), so a bad or truncated backup never touches
+    // the existing database.
+    QSaveFile out(destination);
+
+    if (!in.open(QIODevice::ReadOnly)) {
+        message = QString("Cannot open %1: %2").arg(backupPath, in.errorString());
+    } else if (!out.open(QIODevice::WriteOnly)) {
+        message = QString("Cannot create %1: %2").arg(destination, out.errorString());
+    } else {
+        QDataStream stream(&in);
+        stream.setVersion(BackupStreamVersion);
+        quint32 magic = 0, version = 0;
+        stream >> magic >> version;
+        if (magic != BackupMagic || version != BackupVersion) {
+            message = QString("%1 is not a database backup").arg(backupPath);
+        }
+
+        // Only the empty terminator chunk ends a complete backup.
+        while (message.isEmpty()) {
+            QByteArray chunk;
+            stream >> chunk;
+            if (stream.status() != QDataStream::Ok) {
+                message = QString("%1 is truncated").arg(backupPath);
+                break;
+            }
+            if (chunk.isEmpty()) break; // terminator
+
+            const QByteArray data = qUncompress(chunk);
+            if (data.isEmpty() || out.write(data) != data.size()) {
+                message = QString("Failed to restore %1 into %2").arg(backupPath, destination);
+            }
+        }
+    }
+    in.close();
+
+    if (message.isEmpty()) {
+        // WAL side files of the old database would be replayed onto the
+        // restored image and corrupt it.
+        QFile::remove(destination + "-wal");
+        QFile::remove(destination + "-shm");
+        if (!out.commit()) {
+            message = QString("Cannot replace %1: %2").arg(destination, out.errorString());
+        }
+    } else {
+        out.cancelWriting();
+    }
+
+    if (!message.isEmpty()) {
+        qDebug() << "Backup restore failed:" << message;
+        if (error) *error = message;
+        return false;
+    }
+    return true;
+}
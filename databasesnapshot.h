@@ -0,0 +1,80 @@
+#ifndef DATABASESNAPSHOT_H
+#define DATABASESNAPSHOT_H
+
+#include <QObject>
+#include <QString>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTimer>
+
+// Point-in-time, read-only copy of a SQLite database for reports, exports and
+// aggregate jobs.
+//
+// The constructor copies the live database into a private temporary file with
+// VACUUM INTO and opens a QSQLITE connection on it for the calling thread.
+// Long queries against the snapshot never take locks on the live file, so
+// they do not contend with the interactive widgets. The connection and the
+// file are removed when the object goes out of scope.
+class DatabaseSnapshot {
+public:
+    explicit DatabaseSnapshot(const QString &sourceDatabase);
+    ~DatabaseSnapshot();
+
+    DatabaseSnapshot(const DatabaseSnapshot &) = delete;
+    DatabaseSnapshot &operator=(const DatabaseSnapshot &) = delete;
+
+    bool isValid() const { return m_db.isOpen(); }
+    QSqlDatabase database() const { return m_db; }
+    QString lastError() const { return m_lastError; }
+
+    // Writes a consistent copy of source to destination through a private
+    // QSQLITE connection, so the copy goes through the same SQLite library and
+    // locks as the rest of the application. In WAL mode writers keep
+    // committing while it runs. Safe to call from any thread.
+    static bool copy(const QString &source, const QString &destination, QString *error = nullptr);
+
+private:
+    QTemporaryDir m_dir;
+    QString m_connectionName;
+    QSqlDatabase m_db;
+    QString m_lastError;
+};
+
+// Periodically writes compressed backups of the database into a directory
+// and keeps only the most recent ones. Backups run on the thread pool; at
+// most one is in flight at a time. A backup is a sequence of qCompress()ed
+// chunks, so it is never held in memory as a whole; use restore() to turn
+// one back into a database file.
+class BackupScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    BackupScheduler(const QString &databaseName, const QString &backupDir, QObject *parent = nullptr);
+
+    // Backs up right away if the newest backup is older than the interval
+    // (or there is none), then repeats every interval while the app runs.
+    void start(int intervalMinutes);
+    void stop() { m_timer.stop(); }
+    void setKeepCount(int count) { m_keepCount = qMax(1, count); }
+
+    // Decompresses a backup into destination, which must not be open. The
+    // existing file is only replaced once the whole backup has decoded.
+    static bool restore(const QString &backupPath, const QString &destination, QString *error = nullptr);
+
+public slots:
+    void backupNow();
+
+signals:
+    void backupFinished(bool ok, const QString &pathOrError);
+
+private:
+    static QString writeBackup(const QString &databaseName, const QString &backupDir, int keepCount, bool *ok);
+
+    QString m_databaseName;
+    QString m_backupDir;
+    int m_keepCount;
+    bool m_running;
+    QTimer m_timer;
+};
+
+#endif // DATABASESNAPSHOT_H
@@ -8,6 +8,13 @@
 #include <QHeaderView>
 #include <QItemSelectionModel>
 #include <QDate>
+#include <QFileDialog>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <memory>
+
+#include "statementgenerator.h"
 
 LoansWidgets::LoansWidgets(QWidget *parent, const QString &connectionName) :
     QWidget(parent),
@@ -43,6 +50,9 @@ LoansWidgets::LoansWidgets(QWidget *parent, const QString &connectionName) :
     // Add loan
     connect(ui->addLoanButton, &QPushButton::clicked, this, &LoansWidgets::addLoan);
 
+    // Monthly statements and guarantor letters
+    connect(ui->generateStatementsButton, &QPushButton::clicked, this, &LoansWidgets::generateStatements);
+
     // Borrower selection
     connect(ui->borrowerTable->selectionModel(), &QItemSelectionModel::currentRowChanged,
             this, &LoansWidgets::borrowerSelected);
@@ -254,3 +264,28 @@ void LoansWidgets::onLoanSelected()
 
   //  ui->textLoanDetails->setPlainText(details);
 }
+
+void LoansWidgets::generateStatements()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, "پوشه خروجی صورت‌حساب‌ها");
+    if (dir.isEmpty()) return;
+
+    // The generator reads from its own snapshot on the worker thread, so the
+    // UI connection stays free for edits while the batch runs.
+    auto generator = std::make_shared<StatementGenerator>(db.databaseName(), dir);
+
+    auto *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, generator]() {
+        ui->generateStatementsButton->setEnabled(true);
+        if (watcher->result()) {
+            QMessageBox::information(this, "صدور صورت‌حساب",
+                                     QString("%1 فایل ایجاد شد.").arg(generator->generatedCount()));
+        } else {
+            QMessageBox::critical(this, "خطا در صدور صورت‌حساب", generator->lastError());
+        }
+        watcher->deleteLater();
+    });
+
+    ui->generateStatementsButton->setEnabled(false);
+    watcher->setFuture(QtConcurrent::run([generator]() { return generator->run(); }));
+}
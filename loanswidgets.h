@@ -33,6 +33,7 @@ private slots:
     void guarantorSelectionChanged();
     void addLoan();
     void onLoanSelected();
+    void generateStatements();
 
 private:
     void setupModels();
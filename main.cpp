@@ -1,9 +1,28 @@
 #include <QApplication>
 #include <QPushButton>
+#include <QCommandLineParser>
+#include <QMessageBox>
 #include "mainwindow.h"
+#include "databasesnapshot.h"
 
 int main(int argc, char *argv[]) {
     QApplication a(argc, argv);
+
+    // Restoring has to happen before MainWindow opens people.db
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption restoreOption("restore", "Restore people.db from a backup file before starting.", "backup");
+    parser.addOption(restoreOption);
+    parser.process(a);
+
+    if (parser.isSet(restoreOption)) {
+        QString error;
+        if (!BackupScheduler::restore(parser.value(restoreOption), "people.db", &error)) {
+            QMessageBox::critical(nullptr, "خطای بازیابی", error);
+            return 1;
+        }
+    }
+
     MainWindow mainwindow;
     mainwindow.show();
 
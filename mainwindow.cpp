@@ -1,3 +1,4 @@
+#include "databasesnapshot.h"
 #include "loanswidgets.h"
 #include "MainWindow.h"
 #include "personwidget.h"
@@ -7,6 +8,9 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), ui(new Ui::MainWindow) {
@@ -27,6 +31,14 @@ MainWindow::MainWindow(QWidget* parent)
         // still continue; widgets will show errors if DB unavailable
     } else {
         QSqlQuery q(db);
+        // WAL lets snapshots and backups read while the widgets keep writing
+        QString journalMode;
+        if (q.exec("PRAGMA journal_mode=WAL") && q.next()) journalMode = q.value(0).toString();
+        if (journalMode.compare("wal", Qt::CaseInsensitive) != 0) {
+            qDebug() << "Failed to enable WAL journal mode:"
+                     << (journalMode.isEmpty() ? q.lastError().text() : journalMode);
+        }
+
         // persons table (if not exists)
         q.exec(R"(
             CREATE TABLE IF NOT EXISTS persons (
@@ -59,6 +71,15 @@ MainWindow::MainWindow(QWidget* parent)
                "FOREIGN KEY(guarantor4_id) REFERENCES persons(id),"
                "FOREIGN KEY(guarantor5_id) REFERENCES persons(id)"
                ");");
+        // guarantors of each loan; indexed both ways for statements and letters
+        q.exec(R"(
+            CREATE TABLE IF NOT EXISTS loan_guarantors (
+                loan_id INTEGER NOT NULL REFERENCES loans(id),
+                person_id INTEGER NOT NULL REFERENCES persons(id)
+            )
+        )");
+        q.exec("CREATE INDEX IF NOT EXISTS idx_loan_guarantors_loan ON loan_guarantors(loan_id)");
+        q.exec("CREATE INDEX IF NOT EXISTS idx_loan_guarantors_person ON loan_guarantors(person_id)");
 
 
         // Create widgets (they will use the default DB connection)
@@ -68,6 +89,14 @@ MainWindow::MainWindow(QWidget* parent)
         // Add widgets to the tab widget
         ui->tabWidget->addTab(person, "اشخاص");
         ui->tabWidget->addTab(loans, "لیست تسهیلات");
+
+        // Daily compressed backups next to the database, taken online
+        BackupScheduler* backups = new BackupScheduler(
+            db.databaseName(), QFileInfo(db.databaseName()).absoluteDir().filePath("backups"), this);
+        connect(backups, &BackupScheduler::backupFinished, this, [](bool ok, const QString &pathOrError) {
+            if (!ok) qDebug() << "Backup failed:" << pathOrError;
+        });
+        backups->start(24 * 60);
     }
 }
     MainWindow::~MainWindow() {
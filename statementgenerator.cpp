@@ -0,0 +1,234 @@
+#include "statementgenerator.h"
+#include "databasesnapshot.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDir>
+#include <QFile>
+#include <QBuffer>
+#include <QDate>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QTextDocument>
+#include <QtConcurrent/QtConcurrentMap>
+
+// Both queries share the same column layout so a single streaming loop can
+// group them by person (column 0). Rows must be ordered by person id. The
+// bound value is the last day of the period; dates are stored as yyyy-MM-dd
+// text, so a string comparison selects loans up to the end of the period.
+static const char *BorrowerStatementsSql = R"(
+    SELECT p.id, p.name, p.ssn,
+           l.id, l.amount, l.percentage, l.description, l.date,
+           (SELECT GROUP_CONCAT(g.name, '، ')
+              FROM loan_guarantors lg
+              JOIN persons g ON g.id = lg.person_id
+             WHERE lg.loan_id = l.id) AS counterparties
+    FROM loans l
+    JOIN persons p ON p.id = l.borrower_id
+    WHERE l.date <= ?
+    ORDER BY l.borrower_id, l.date
+)";
+
+static const char *GuarantorLettersSql = R"(
+    SELECT g.id, g.name, g.ssn,
+           l.id, l.amount, l.percentage, l.description, l.date,
+           b.name AS counterparties
+    FROM loan_guarantors lg
+    JOIN persons g ON g.id = lg.person_id
+    JOIN loans l ON l.id = lg.loan_id
+    LEFT JOIN persons b ON b.id = l.borrower_id
+    WHERE l.date <= ?
+    ORDER BY lg.person_id, l.date
+)";
+
+StatementGenerator::StatementGenerator(const QString &databaseName, const QString &outputDir) :
+    m_databaseName(databaseName),
+    m_outputDir(outputDir),
+    m_format(Pdf),
+    m_batchSize(500),
+    m_generated(0)
+{
+    setPeriod(QDate::currentDate());
+}
+
+void StatementGenerator::setPeriod(const QDate &month)
+{
+    const QDate first(month.year(), month.month(), 1);
+    m_period = first.toString("yyyy-MM");
+    m_periodEnd = first.addMonths(1).addDays(-1).toString("yyyy-MM-dd");
+}
+
+bool StatementGenerator::run()
+{
+    m_generated = 0;
+    m_lastError.clear();
+
+    if (!QDir().mkpath(m_outputDir)) {
+        m_lastError = QString("Cannot create output directory %1").arg(m_outputDir);
+        return false;
+    }
+
+    // Report queries run against a private snapshot of the database, opened
+    // on this thread, so they never hold locks on the live file that the
+    // interactive widgets write to.
+    DatabaseSnapshot snapshot(m_databaseName);
+    if (!snapshot.isValid()) {
+        m_lastError = snapshot.lastError();
+        return false;
+    }
+
+    QSqlDatabase db = snapshot.database();
+    return generate(db, StatementJob::BorrowerStatement, BorrowerStatementsSql)
+           && generate(db, StatementJob::GuarantorLetter, GuarantorLettersSql);
+}
+
+bool StatementGenerator::generate(QSqlDatabase &db, StatementJob::Kind kind, const QString &sql)
+{
+    QSqlQuery q(db);
+    q.setForwardOnly(true); // stream rows instead of caching the whole result
+
+    q.prepare(sql);
+    q.addBindValue(m_periodEnd);
+    if (!q.exec()) {
+        m_lastError = q.lastError().text();
+        return false;
+    }
+
+    // Up to two batches are in flight: while the newest one renders on the
+    // thread pool, the previous one is written to disk here, and then the
+    // next one is read from the database.
+    QFuture<RenderedStatement> pending;
+    QList<StatementJob> batch;
+    batch.reserve(m_batchSize);
+
+    bool hasRow = q.next();
+    while (hasRow) {
+        StatementJob job;
+        job.kind = kind;
+        job.personId = q.value(0).toInt();
+        job.personName = q.value(1).toString();
+        job.ssn = q.value(2).toString();
+
+        while (hasRow && q.value(0).toInt() == job.personId) {
+            StatementLoan loan;
+            loan.id = q.value(3).toInt();
+            loan.amount = q.value(4).toDouble();
+            loan.percentage = q.value(5).toDouble();
+            loan.description = q.value(6).toString();
+            loan.date = q.value(7).toString();
+            loan.counterparties = q.value(8).toString();
+            job.loans.append(loan);
+            hasRow = q.next();
+        }
+        batch.append(job);
+
+        if (batch.size() >= m_batchSize || !hasRow) {
+            QFuture<RenderedStatement> next = QtConcurrent::mapped(std::move(batch), [this](const StatementJob &j) {
+                return render(j);
+            });
+            const bool written = writeBatch(pending);
+            pending = next;
+            if (!written) {
+                pending.waitForFinished();
+                return false;
+            }
+            batch = QList<StatementJob>();
+            batch.reserve(m_batchSize);
+        }
+    }
+
+    // A forward-only query that fails mid-stream just stops returning rows;
+    // report it instead of finishing with a partial set of documents.
+    if (q.lastError().isValid()) {
+        pending.waitForFinished();
+        m_lastError = QString("Statement query stopped early: %1").arg(q.lastError().text());
+        return false;
+    }
+
+    return writeBatch(pending);
+}
+
+bool StatementGenerator::writeBatch(QFuture<RenderedStatement> &pending)
+{
+    if (!pending.isValid()) return true;
+
+    const QList<RenderedStatement> results = pending.results();
+    pending = QFuture<RenderedStatement>();
+
+    const QDir dir(m_outputDir);
+    for (const RenderedStatement &doc : results) {
+        QFile f(dir.filePath(doc.fileName));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(doc.data) != doc.data.size()) {
+            m_lastError = QString("Failed to write %1: %2").arg(f.fileName(), f.errorString());
+            return false;
+        }
+        ++m_generated;
+    }
+    return true;
+}
+
+RenderedStatement StatementGenerator::render(const StatementJob &job) const
+{
+    RenderedStatement out;
+    const QString prefix = job.kind == StatementJob::BorrowerStatement ? "statement" : "guarantor";
+    const QString html = toHtml(job);
+
+    if (m_format == Html) {
+        out.fileName = QString("%1_%2_%3.html").arg(prefix, m_period).arg(job.personId);
+        out.data = html.toUtf8();
+        return out;
+    }
+
+    out.fileName = QString("%1_%2_%3.pdf").arg(prefix, m_period).arg(job.personId);
+    QBuffer buffer(&out.data);
+    buffer.open(QIODevice::WriteOnly);
+    {
+        QPdfWriter writer(&buffer);
+        writer.setPageSize(QPageSize(QPageSize::A4));
+        writer.setResolution(150);
+
+        QTextDocument doc;
+        doc.setHtml(html);
+        doc.print(&writer);
+    }
+    return out;
+}
+
+QString StatementGenerator::toHtml(const StatementJob &job) const
+{
+    const bool borrower = job.kind == StatementJob::BorrowerStatement;
+
+    QString html;
+    html.reserve(1024 + job.loans.size() * 256);
+    html += "<html dir=\"rtl\"><head><meta charset=\"utf-8\"></head><body>";
+    html += borrower ? "<h2>صورت‌حساب وام‌گیرنده</h2>" : "<h2>اطلاعیه ضامن</h2>";
+    html += QString("<p>نام: %1<br>شماره ملی: %2<br>دوره: %3<br>تاریخ صدور: %4</p>")
+                .arg(job.personName.toHtmlEscaped(),
+                     job.ssn.toHtmlEscaped(),
+                     m_period,
+                     QDate::currentDate().toString("yyyy-MM-dd"));
+
+    html += "<table border=\"1\" cellspacing=\"0\" cellpadding=\"4\" width=\"100%\"><tr>"
+            "<th>شناسه وام</th><th>مبلغ</th><th>درصد سود</th><th>تاریخ</th><th>توضیحات</th>";
+    html += borrower ? "<th>ضامن‌ها</th>" : "<th>وام‌گیرنده</th>";
+    html += "</tr>";
+
+    double total = 0.0;
+    for (const StatementLoan &loan : job.loans) {
+        total += loan.amount;
+        html += QString("<tr><td>%1</td><td>%2</td><td>%3%</td><td>%4</td><td>%5</td><td>%6</td></tr>")
+                    .arg(QString::number(loan.id),
+                         QString::number(loan.amount, 'f', 0),
+                         QString::number(loan.percentage),
+                         loan.date.toHtmlEscaped(),
+                         loan.description.toHtmlEscaped(),
+                         loan.counterparties.isEmpty() ? "هیچ‌کدام" : loan.counterparties.toHtmlEscaped());
+    }
+    html += "</table>";
+
+    html += QString("<p>تعداد وام‌ها: %1<br>جمع مبالغ: %2</p>")
+                .arg(job.loans.size())
+                .arg(QString::number(total, 'f', 0));
+    html += "</body></html>";
+    return html;
+}
@@ -0,0 +1,84 @@
+#ifndef STATEMENTGENERATOR_H
+#define STATEMENTGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QByteArray>
+#include <QDate>
+#include <QFuture>
+#include <QSqlDatabase>
+
+// One loan line as it appears on a statement. For borrower statements
+// "counterparties" holds the guarantors, for guarantor letters the borrower.
+struct StatementLoan {
+    int id = 0;
+    double amount = 0.0;
+    double percentage = 0.0;
+    QString description;
+    QString date;
+    QString counterparties;
+};
+
+// Everything needed to render one document, detached from the database so
+// it can be handed to a worker thread.
+struct StatementJob {
+    enum Kind { BorrowerStatement, GuarantorLetter };
+
+    Kind kind = BorrowerStatement;
+    int personId = -1;
+    QString personName;
+    QString ssn;
+    QList<StatementLoan> loans;
+};
+
+struct RenderedStatement {
+    QString fileName;
+    QByteArray data;
+};
+
+// Monthly batch generator for borrower statements and guarantor letters.
+//
+// Loans are streamed grouped by person from a read-only DatabaseSnapshot,
+// rendered in parallel with QtConcurrent and written to disk one batch at a
+// time, so memory stays bounded regardless of the number of loans. run()
+// blocks and opens its connection on the calling thread, so it is meant to be
+// called from a worker (e.g. through QtConcurrent::run).
+class StatementGenerator {
+public:
+    enum Format { Html, Pdf };
+
+    StatementGenerator(const QString &databaseName, const QString &outputDir);
+
+    void setFormat(Format format) { m_format = format; }
+    // Statement period. Only loans dated up to the end of that month are
+    // included, and the period is part of every file name so monthly runs
+    // into the same folder never overwrite each other. Defaults to the
+    // current month.
+    void setPeriod(const QDate &month);
+    void setBatchSize(int size) { m_batchSize = qMax(1, size); }
+
+    // Returns false on failure; see lastError(). generatedCount() is valid
+    // either way and reports how many files were written.
+    bool run();
+
+    int generatedCount() const { return m_generated; }
+    QString lastError() const { return m_lastError; }
+
+private:
+    bool generate(QSqlDatabase &db, StatementJob::Kind kind, const QString &sql);
+    bool writeBatch(QFuture<RenderedStatement> &pending);
+    RenderedStatement render(const StatementJob &job) const;
+    QString toHtml(const StatementJob &job) const;
+
+    QString m_databaseName;
+    QString m_outputDir;
+    Format m_format;
+    QString m_period;
+    QString m_periodEnd;
+    int m_batchSize;
+    int m_generated;
+    QString m_lastError;
+};
+
+#endif // STATEMENTGENERATOR_H